@@ -1,8 +1,11 @@
 #include <llvm/Pass.h>
+#include <llvm/IR/Module.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/Transforms/Utils/BasicBlockUtils.h>
 #include <llvm/IR/Constants.h>
 
+#include "DeadInstCleanup.h"
+
 using namespace llvm;
 
 namespace {
@@ -15,8 +18,13 @@ namespace {
 
         void getAnalysisUsage(AnalysisUsage &AU) const override {}
 
+        bool doFinalization(Module &M) override {
+            Cleanup.report("algebraic-identity");
+            return false;
+        }
+
         template<class DataType>
-        static bool handleAddInstruction(BasicBlock &B, Instruction &I) {
+        bool handleAddInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             bool changed = false;
             if (auto *CI1 = dyn_cast<DataType>(I.getOperand(0))) {
@@ -29,14 +37,13 @@ namespace {
                 }
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleIntSubInstruction(BasicBlock &B, Instruction &I) {
+        bool handleIntSubInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
@@ -50,14 +57,13 @@ namespace {
                 IdentityValue = ConstantInt::get(op_s->getType(), 0);
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFSubInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFSubInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
@@ -71,14 +77,13 @@ namespace {
                 IdentityValue = ConstantFP::get(op_s->getType(), 0);
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFDivInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFDivInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
@@ -92,14 +97,13 @@ namespace {
                 IdentityValue = ConstantFP::get(op_s->getType(), 1);
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleIntDivInstruction(BasicBlock &B, Instruction &I) {
+        bool handleIntDivInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
@@ -113,14 +117,13 @@ namespace {
                 IdentityValue = ConstantInt::get(op_s->getType(), 1);
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleIntMulInstruction(BasicBlock &B, Instruction &I) {
+        bool handleIntMulInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             bool changed = false;
             auto *CI1 = dyn_cast<ConstantInt>(I.getOperand(0));
@@ -144,14 +147,13 @@ namespace {
                 }
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFMulInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFMulInstruction(BasicBlock &B, Instruction &I) {
             Value *IdentityValue = nullptr;
             bool changed = false;
 
@@ -176,8 +178,7 @@ namespace {
                 }
             }
             if (IdentityValue) {
-                I.replaceAllUsesWith(IdentityValue);
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, IdentityValue);
                 changed = true;
             }
             return changed;
@@ -207,9 +208,13 @@ namespace {
                         changed |= handleFMulInstruction(B, I);
                     }
                 }
+                changed |= Cleanup.flush();
             }
             return changed;
         }
+
+    private:
+        DeadInstCleanup Cleanup;
     }; // class AlgebraicIdentity
 
     char AlgebraicIdentity::ID = 0;
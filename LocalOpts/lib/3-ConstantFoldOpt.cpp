@@ -3,6 +3,8 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/Transforms/Utils/BasicBlockUtils.h>
 
+#include "DeadInstCleanup.h"
+
 using namespace llvm;
 
 namespace {
@@ -15,117 +17,118 @@ namespace {
 
         void getAnalysisUsage(AnalysisUsage &AU) const override {}
 
-        static bool handleIntMulInstruction(BasicBlock &B, Instruction &I) {
+        bool doFinalization(Module &M) override {
+            Cleanup.report("const-fold-opt");
+            return false;
+        }
+
+        bool handleIntMulInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantInt>(op_f);
             auto CI_S = dyn_cast<ConstantInt>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() * CI_S->getZExtValue()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() *
+                                                                             CI_S->getZExtValue()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFMulInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFMulInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantFP>(op_f);
             auto CI_S = dyn_cast<ConstantFP>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() *
-                                                                      CI_S->getValueAPF().convertToDouble()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() *
+                                                                            CI_S->getValueAPF().convertToDouble()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleIntDivInstruction(BasicBlock &B, Instruction &I) {
+        bool handleIntDivInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantInt>(op_f);
             auto CI_S = dyn_cast<ConstantInt>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() / CI_S->getZExtValue()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() /
+                                                                             CI_S->getZExtValue()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFDivInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFDivInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantFP>(op_f);
             auto CI_S = dyn_cast<ConstantFP>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() /
-                                                                      CI_S->getValueAPF().convertToDouble()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() /
+                                                                            CI_S->getValueAPF().convertToDouble()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleIntAddInstruction(BasicBlock &B, Instruction &I) {
+        bool handleIntAddInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantInt>(op_f);
             auto CI_S = dyn_cast<ConstantInt>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() + CI_S->getZExtValue()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() +
+                                                                             CI_S->getZExtValue()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFAddInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFAddInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantFP>(op_f);
             auto CI_S = dyn_cast<ConstantFP>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() +
-                                                                      CI_S->getValueAPF().convertToDouble()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() +
+                                                                            CI_S->getValueAPF().convertToDouble()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleIntSubInstruction(BasicBlock &B, Instruction &I) {
+        bool handleIntSubInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantInt>(op_f);
             auto CI_S = dyn_cast<ConstantInt>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() - CI_S->getZExtValue()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantInt::get(CI_F->getType(), CI_F->getZExtValue() -
+                                                                             CI_S->getZExtValue()));
                 changed = true;
             }
             return changed;
         }
 
-        static bool handleFSubInstruction(BasicBlock &B, Instruction &I) {
+        bool handleFSubInstruction(BasicBlock &B, Instruction &I) {
             Value *op_f = I.getOperand(0);
             Value *op_s = I.getOperand(1);
             auto CI_F = dyn_cast<ConstantFP>(op_f);
             auto CI_S = dyn_cast<ConstantFP>(op_s);
             bool changed = false;
             if (CI_F && CI_S) {
-                I.replaceAllUsesWith(ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() -
-                                                                      CI_S->getValueAPF().convertToDouble()));
-                I.eraseFromParent();
+                Cleanup.replaceAndErase(I, ConstantFP::get(CI_F->getType(), CI_F->getValueAPF().convertToDouble() -
+                                                                            CI_S->getValueAPF().convertToDouble()));
                 changed = true;
             }
             return changed;
@@ -156,9 +159,13 @@ namespace {
                         changed |= handleFMulInstruction(B, I);
                     }
                 }
+                changed |= Cleanup.flush();
             }
             return changed;
         }
+
+    private:
+        DeadInstCleanup Cleanup;
     }; // class ConstFoldOpt
 
     char ConstFoldOpt::ID = 0;
@@ -0,0 +1,64 @@
+#include "DeadInstCleanup.h"
+
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Local.h>
+
+using namespace llvm;
+
+static cl::opt<bool> ReportCleanup("localopts-cleanup-report", cl::init(false), cl::Hidden,
+                                   cl::desc("Report instructions and bytes of IR freed by LocalOpts"));
+
+/// Approximate heap footprint of an instruction: the object itself plus the
+/// co-allocated operand list.
+static uint64_t instructionBytes(const Instruction &I) {
+    uint64_t Size = sizeof(Instruction);
+    if (isa<BinaryOperator>(I)) {
+        Size = sizeof(BinaryOperator);
+    } else if (isa<CastInst>(I)) {
+        Size = sizeof(CastInst);
+    } else if (isa<CmpInst>(I)) {
+        Size = sizeof(CmpInst);
+    } else if (isa<GetElementPtrInst>(I)) {
+        Size = sizeof(GetElementPtrInst);
+    } else if (isa<LoadInst>(I)) {
+        Size = sizeof(LoadInst);
+    }
+    return Size + I.getNumOperands() * sizeof(Use);
+}
+
+void DeadInstCleanup::replaceAndErase(Instruction &I, Value *V) {
+    I.replaceAllUsesWith(V);
+    DeadInsts.push_back(&I);
+}
+
+bool DeadInstCleanup::flush() {
+    if (DeadInsts.empty()) {
+        return false;
+    }
+    while (!DeadInsts.empty()) {
+        Instruction *I = DeadInsts.pop_back_val();
+        for (Use &U: I->operands()) {
+            Value *Op = U.get();
+            U.set(nullptr);
+            if (auto *OpI = dyn_cast_or_null<Instruction>(Op)) {
+                if (OpI->use_empty() && isInstructionTriviallyDead(OpI)) {
+                    DeadInsts.push_back(OpI);
+                }
+            }
+        }
+        ++NumFreedInsts;
+        NumFreedBytes += instructionBytes(*I);
+        I->eraseFromParent();
+    }
+    return true;
+}
+
+void DeadInstCleanup::report(StringRef PassName) const {
+    if (ReportCleanup) {
+        errs() << PassName << ": freed " << NumFreedInsts << " instructions (" << NumFreedBytes
+               << " bytes of IR)\n";
+    }
+}
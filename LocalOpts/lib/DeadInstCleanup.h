@@ -0,0 +1,34 @@
+#ifndef LOCALOPTS_DEADINSTCLEANUP_H
+#define LOCALOPTS_DEADINSTCLEANUP_H
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Instruction.h>
+
+namespace llvm {
+
+    /// Collects instructions that a LocalOpts pass has rewritten away and erases
+    /// them, together with every operand chain that becomes trivially dead, in
+    /// one batch at the end of each basic block. The worklist is reused across
+    /// blocks and functions, so flushing does not reallocate once it has grown.
+    class DeadInstCleanup {
+    public:
+        /// Replaces all uses of \p I with \p V and queues \p I for erasure.
+        void replaceAndErase(Instruction &I, Value *V);
+
+        /// Erases the queued instructions and any operand that lost its last
+        /// use as a result. Returns true if anything was erased.
+        bool flush();
+
+        /// Prints the totals to errs() when -localopts-cleanup-report is set.
+        void report(StringRef PassName) const;
+
+    private:
+        SmallVector<Instruction *, 16> DeadInsts;
+        uint64_t NumFreedInsts = 0;
+        uint64_t NumFreedBytes = 0;
+    };
+
+} // namespace llvm
+
+#endif // LOCALOPTS_DEADINSTCLEANUP_H